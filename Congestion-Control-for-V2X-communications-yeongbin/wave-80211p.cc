@@ -29,6 +29,7 @@
  * to "Outside the Context of a BSS")."
  */
 
+#include "ns3/abort.h"
 #include "ns3/vector.h"
 #include "ns3/string.h"
 #include "ns3/socket.h"
@@ -63,6 +64,10 @@ using std::to_string;
 #define MAX_NODE 51
 #define COLUMN 10
 #define ROW 5
+#define BSM_PORT 80
+#define PVD_PORT 81
+#define BSM_SLOTS 249
+#define BSM_SENDERS 2
 NS_LOG_COMPONENT_DEFINE ("WifiSimpleOcb");
 
 /*
@@ -105,19 +110,47 @@ void ReceivePacket_BSM (Ptr<Socket> socket)
     }
 }
 
-static void GenerateTraffic (Ptr<Socket> socket, uint32_t pktSize,
-                             uint32_t pktCount, Time pktInterval )
+// Every send is a copy-on-write copy of a template packet built once per
+// message type in main(), so no payload buffer is allocated per packet.
+// The socket is the node's only send socket and stays open for the whole run.
+static void GenerateTraffic (Ptr<Socket> socket, Ptr<const Packet> pktTemplate,
+                             Address dest, uint32_t pktCount, Time pktInterval )
 {
   if (pktCount > 0)
     {
-      socket->Send (Create<Packet> (pktSize));
+      socket->SendTo (pktTemplate->Copy (), 0, dest);
       Simulator::Schedule (pktInterval, &GenerateTraffic,
-                           socket, pktSize,pktCount - 1, pktInterval);
+                           socket, pktTemplate, dest, pktCount - 1, pktInterval);
     }
-  else
+}
+
+// Precomputes which nodes broadcast a BSM in each slot. Senders of a slot are
+// drawn without replacement and never repeat the previous slot's senders.
+// The picked senders are parked at the tail of the permutation, so the next
+// slot only shuffles the head: no rejection loop, O(senders) per slot.
+static std::vector<std::vector<uint32_t> >
+BuildBsmSchedule (uint32_t numNodes, uint32_t numSlots, uint32_t sendersPerSlot,
+                  uint32_t seed)
+{
+  std::mt19937 gen (seed);
+  std::vector<uint32_t> order (numNodes);
+  for (uint32_t k = 0; k < numNodes; k++)
+    order[k] = k;
+
+  std::vector<std::vector<uint32_t> > schedule (numSlots);
+  uint32_t head = numNodes - sendersPerSlot;
+  for (uint32_t slot = 0; slot < numSlots; slot++)
     {
-      socket->Close ();
+      for (uint32_t s = 0; s < sendersPerSlot; s++)
+        {
+          std::uniform_int_distribution<uint32_t> dis (s, head - 1);
+          std::swap (order[s], order[dis (gen)]);
+          schedule[slot].push_back (order[s]);
+        }
+      for (uint32_t s = 0; s < sendersPerSlot; s++)
+        std::swap (order[s], order[head + s]);
     }
+  return schedule;
 }
 
 int main (int argc, char *argv[])
@@ -128,6 +161,10 @@ int main (int argc, char *argv[])
   std::string animFile = "wave-80211p.xml" ;  // Name of file for animation output
   double interval = 1.0; // seconds
   bool verbose = false;
+  uint32_t numNodes = MAX_NODE; // RSU + OBUs
+  uint32_t numSlots = BSM_SLOTS; // BSM slots of 20ms
+  uint32_t sendersPerSlot = BSM_SENDERS;
+  uint32_t seed = 1; // seed of the BSM sender schedule
 
   CommandLine cmd (__FILE__);
 
@@ -137,13 +174,19 @@ int main (int argc, char *argv[])
   cmd.AddValue ("interval", "interval (seconds) between packets", interval);
   cmd.AddValue ("verbose", "turn on all WifiNetDevice log components", verbose);
   cmd.AddValue ("animFile",  "File Name for Animation Output", animFile);
+  cmd.AddValue ("numNodes", "number of nodes including the RSU", numNodes);
+  cmd.AddValue ("numSlots", "number of BSM broadcast slots", numSlots);
+  cmd.AddValue ("sendersPerSlot", "number of BSM senders in each slot", sendersPerSlot);
+  cmd.AddValue ("seed", "seed of the BSM sender schedule", seed);
   cmd.Parse (argc, argv);
+  NS_ABORT_MSG_IF (sendersPerSlot == 0 || numNodes < 2 * sendersPerSlot,
+                   "numNodes must be at least twice sendersPerSlot");
   // Convert to time object
   Time interPacketInterval = Seconds (interval);
 
 
   NodeContainer c;
-  c.Create (MAX_NODE);
+  c.Create (numNodes);
 
   // The below set of helpers will help us to put together the wifi NICs we want
   YansWifiPhyHelper wifiPhy =  YansWifiPhyHelper::Default ();
@@ -171,11 +214,8 @@ int main (int argc, char *argv[])
   Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator> ();
   positionAlloc->Add (Vector (9, 0.0, 0.0));
 
-  for(int i =0; i<ROW; i++)
-  {
-    for(int j=0;j<COLUMN;j++)
-      positionAlloc->Add (Vector (2.0*j, 2.0*i+1, 0.0));
-  }
+  for(uint32_t k=0; k<numNodes-1; k++)
+    positionAlloc->Add (Vector (2.0*(k%COLUMN), 2.0*(k/COLUMN)+1, 0.0));
   mobility.SetPositionAllocator (positionAlloc);
   mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
   mobility.Install (c);
@@ -191,15 +231,16 @@ int main (int argc, char *argv[])
   Ipv4InterfaceContainer i = ipv4.Assign (devices);
 
   TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
+  // Template packets, one per message type
+  Ptr<const Packet> pvdTemplate = Create<Packet> (packetSize);
+  Ptr<const Packet> bsmTemplate = Create<Packet> (packetSize);
   /// RSU가 OBU에게 broadcast message를 보낼 때!!
   // 1. 다중 node의 동시 broadcast 구현
   // 2. broadcast Interval을 부여
   //   - ns3 내에 timer = 100ms 
 
-  std::random_device rd;
-  std::mt19937 gen(rd());
-  std::uniform_int_distribution<int> dis(0,50);
-
+  std::vector<std::vector<uint32_t> > schedule =
+    BuildBsmSchedule (numNodes, numSlots, sendersPerSlot, seed);
 
   // Ptr<Socket> recvSink = Socket::CreateSocket (c.Get (0), tid);
   // InetSocketAddress local = InetSocketAddress (i.GetAddress(0), 80);
@@ -224,74 +265,51 @@ int main (int argc, char *argv[])
 
 
 
+//////////////////////////////////////////////////////////////////////////////////////
+// sockets are created once per node and reused by every PVD round and BSM slot
+  std::vector<Ptr<Socket> > sources (numNodes);
+  for(uint32_t k=0; k<numNodes; k++)
+    {
+      Ptr<Socket> recvSink = Socket::CreateSocket (c.Get (k), tid);
+      InetSocketAddress local = InetSocketAddress (Ipv4Address("255.255.255.255"), BSM_PORT);
+      recvSink->Bind (local);
+      // recvSink->SetRecvCallback (MakeCallback (&BsmApplication::ReceiveWavePacket, recvSink));
+      recvSink->SetRecvCallback (MakeCallback (&ReceivePacket_BSM));
+
+      sources[k] = Socket::CreateSocket (c.Get (k), tid);
+      sources[k]->SetAllowBroadcast (true);
+      sources[k]->Bind ();
+    }
+  Ptr<Socket> pvdSink = Socket::CreateSocket (c.Get (0), tid);
+  pvdSink->Bind (InetSocketAddress (i.GetAddress (0), PVD_PORT));
+  pvdSink->SetRecvCallback (MakeCallback(&ReceivePacket_PVD));
+
 //////////////////////////////////////////////////////////////////////////////////////
 // no random PVD Unicast code  
-  int m = 0;                           
-  while(m<5)
+  Address pvdRemote = InetSocketAddress (i.GetAddress (0), PVD_PORT);
+  for(int m=0; m<5; m++)
     {
-    for(int i=1; i<MAX_NODE; i++)
+    for(uint32_t k=1; k<numNodes; k++)
       {
-        InetSocketAddress remote = InetSocketAddress (Ipv4Address ("10.1.1.1"), i);
-        Ptr<Socket> recvSink = Socket::CreateSocket (c.Get (0), tid);
-        InetSocketAddress local = InetSocketAddress (Ipv4Address("10.1.1.1"), i);
-        recvSink->Bind (local);
-        recvSink->SetRecvCallback (MakeCallback(&ReceivePacket_PVD));
-        Ptr<Socket> source = Socket::CreateSocket (c.Get (i), tid);
-        source->SetAllowBroadcast (true);
-        source->Connect (remote);
-        NS_LOG_UNCOND (source->GetNode ()->GetId ());   
-        Simulator::ScheduleWithContext (source->GetNode ()->GetId (),
-                                Seconds (m+0.02*i), &GenerateTraffic,
-                                source, packetSize, numPackets, interPacketInterval);
+        NS_LOG_UNCOND (k);
+        Simulator::ScheduleWithContext (k,
+                                Seconds (m+0.02*k), &GenerateTraffic,
+                                sources[k], pvdTemplate, pvdRemote, numPackets, interPacketInterval);
       }
-      m++;
     }
 
 //////////////////////////////////////////////////////////////////////////////////////
 /// 50개씩 감! --->> BSM Broadcast Success
-  InetSocketAddress remote = InetSocketAddress (Ipv4Address ("255.255.255.255"), 80);
-  int n = 1;
-  int second_node = 1;
-  int second_node_1 = 2;
-  while(n<250)
+  Address bsmRemote = InetSocketAddress (Ipv4Address ("255.255.255.255"), BSM_PORT);
+  for(uint32_t n=1; n<=numSlots; n++)
   {
-    int first_node = dis(gen);
-    int first_node_1 = dis(gen);
-    // NS_LOG_UNCOND (second_node);   
-    // NS_LOG_UNCOND (second_node_1);   
-
-    if(first_node != second_node && first_node != first_node_1 
-                                  && first_node != second_node_1 && first_node_1 != second_node 
-                                  && first_node_1 != second_node_1 && second_node != second_node_1)   
-    {
-      for(int j =0; j<MAX_NODE; j++)
-        {
-          if(first_node != j && second_node != j)
-          {
-          Ptr<Socket> recvSink = Socket::CreateSocket (c.Get (j), tid);
-          InetSocketAddress local = InetSocketAddress (Ipv4Address("255.255.255.255"), 80);
-          recvSink->Bind (local);
-
-          // recvSink->SetRecvCallback (MakeCallback (&BsmApplication::ReceiveWavePacket, recvSink));
-          recvSink->SetRecvCallback (MakeCallback (&ReceivePacket_BSM));                                     
-          }
-        }
-        Ptr<Socket> source = Socket::CreateSocket (c.Get (first_node), tid);
-        Ptr<Socket> source1 = Socket::CreateSocket (c.Get (first_node_1), tid);
-        source->SetAllowBroadcast (true);
-        source->Connect (remote);
-        source1->SetAllowBroadcast (true);
-        source1->Connect (remote);
-        Simulator::ScheduleWithContext (source->GetNode ()->GetId (),
-                                        Seconds (0.02*n+0.015), &GenerateTraffic,
-                                        source, packetSize, numPackets, interPacketInterval);
-        Simulator::ScheduleWithContext (source1->GetNode ()->GetId (),
-                                        Seconds (0.02*n+0.01), &GenerateTraffic,
-                                        source1, packetSize, numPackets, interPacketInterval);
-        second_node = first_node;
-        second_node_1 = first_node_1;
-    }   
-      n++;
+    const std::vector<uint32_t> &senders = schedule[n-1];
+    for(uint32_t s=0; s<senders.size (); s++)
+      {
+        Simulator::ScheduleWithContext (senders[s],
+                                        Seconds (0.02*n+0.01+0.01*s/sendersPerSlot), &GenerateTraffic,
+                                        sources[senders[s]], bsmTemplate, bsmRemote, numPackets, interPacketInterval);
+      }
   }
   AnimationInterface anim (animFile);
   Simulator::Run ();
@@ -0,0 +1,130 @@
+#ifndef V2X_COMMON_H
+#define V2X_COMMON_H
+
+/**
+ * @file V2X_common.h
+ * @brief scenario parameters and ITT policy shared by V2X_scen1.cc and V2X_surrogate.cc
+ * @details this header must not depend on ns-3 so that V2X_surrogate.cc builds on its own
+ */
+
+#include <cfloat>
+#include <cstddef>
+#include <cstring>
+
+#define OBU_NODE 500
+#define RSU_NODE 1
+#define ROW_LINE 10
+#define TOTAL_TIME 100
+#define BSM_PACKET_SIZE 200
+#define BYTE_SIZE 8
+#define INIT_ITT_DATA "20Kb/s" // data rate of BSM in the first second
+#define INIT_ITT 0.080         // ITT of BSM in the first second
+
+/**
+ * @brief one section of the ITT policy table
+ * @param cbr_max upper bound (exclusive) of the CBR section in percent
+ * @param itt_data data rate of BSM delivered to OBUs in the WSA
+ * @param itt inter transmission time that corresponds to itt_data
+ */
+typedef struct {
+  float cbr_max;
+  const char* itt_data;
+  float itt;
+}ITT_POLICY;
+
+/**
+ * @brief ITT is determined according to CBR
+ * @details Depending on the Qualcomm's report, C-V2X Congestion Control Study
+ * @details We decided the section of CBR and values of ITT as follows
+ */
+static const ITT_POLICY itt_policy[] = {
+  {60, "20Kb/s", 0.080},
+  {70, "19Kb/s", 0.084},
+  {80, "18Kb/s", 0.089},
+  {90, "17Kb/s", 0.094},
+  {100, "16Kb/s", 0.100},
+  {110, "15Kb/s", 0.107},
+  {120, "14Kb/s", 0.114},
+  {130, "13Kb/s", 0.123},
+  {140, "12Kb/s", 0.133},
+  {150, "11Kb/s", 0.145},
+  {FLT_MAX, "10Kb/s", 0.160},
+};
+#define ITT_POLICY_NUM (sizeof (itt_policy) / sizeof (itt_policy[0]))
+
+/**
+ * @brief ITT policy that reacts 20% of CBR earlier than itt_policy
+ */
+static const ITT_POLICY itt_policy_early[] = {
+  {40, "20Kb/s", 0.080},
+  {50, "19Kb/s", 0.084},
+  {60, "18Kb/s", 0.089},
+  {70, "17Kb/s", 0.094},
+  {80, "16Kb/s", 0.100},
+  {90, "15Kb/s", 0.107},
+  {100, "14Kb/s", 0.114},
+  {110, "13Kb/s", 0.123},
+  {120, "12Kb/s", 0.133},
+  {130, "11Kb/s", 0.145},
+  {FLT_MAX, "10Kb/s", 0.160},
+};
+
+/**
+ * @brief ITT policy without congestion control, OBUs keep the initial ITT
+ */
+static const ITT_POLICY itt_policy_fixed[] = {
+  {FLT_MAX, INIT_ITT_DATA, INIT_ITT},
+};
+
+/**
+ * @brief ITT policy table that can be selected by name
+ * @param name name of the table
+ * @param sections sections of the table in increasing order of cbr_max
+ * @param num number of sections
+ */
+typedef struct {
+  const char* name;
+  const ITT_POLICY* sections;
+  size_t num;
+}ITT_TABLE;
+
+static const ITT_TABLE itt_tables[] = {
+  {"qualcomm", itt_policy, ITT_POLICY_NUM},
+  {"early", itt_policy_early, sizeof (itt_policy_early) / sizeof (itt_policy_early[0])},
+  {"fixed", itt_policy_fixed, sizeof (itt_policy_fixed) / sizeof (itt_policy_fixed[0])},
+};
+#define ITT_TABLE_NUM (sizeof (itt_tables) / sizeof (itt_tables[0]))
+
+/**
+ * @brief the function that finds an ITT policy table by name
+ * @return the table, or NULL when there is no table with the name
+ */
+inline const ITT_TABLE* FindIttTable (const char* name)
+{
+  for (size_t i = 0; i < ITT_TABLE_NUM; i++)
+    {
+      if (strcmp (itt_tables[i].name, name) == 0)
+        return &itt_tables[i];
+    }
+  return NULL;
+}
+
+/**
+ * @brief the function that finds the section of an ITT policy table for a CBR
+ * @param cbr channel busy ratio in percent
+ * @param table ITT policy table, itt_policy by default
+ * @return section of the table, or NULL when CBR is 0 (no BSM measured) or NaN and ITT is kept
+ */
+inline const ITT_POLICY* FindIttPolicy (float cbr, const ITT_TABLE* table = &itt_tables[0])
+{
+  if (cbr == 0 || cbr != cbr)
+    return NULL;
+  for (size_t i = 0; i + 1 < table->num; i++)
+    {
+      if (cbr < table->sections[i].cbr_max)
+        return &table->sections[i];
+    }
+  return &table->sections[table->num - 1]; // the last section has no upper bound
+}
+
+#endif /* V2X_COMMON_H */
@@ -0,0 +1,120 @@
+#ifndef V2X_METRICS_H
+#define V2X_METRICS_H
+
+/**
+ * @file V2X_metrics.h
+ * @brief live metrics stream from V2X_scen1.cc to V2X_monitor.cc over a Unix domain socket
+ * @details the simulation sends one METRICS datagram per second of simulation time.
+ * @details The socket is non-blocking and send errors are ignored, so a missing, slow or
+ * @details killed reader only drops records and never blocks the simulation thread.
+ * @details this header must not depend on ns-3 so that V2X_monitor.cc builds on its own
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define METRICS_MAGIC 0x56325831 // "V2X1"
+
+/**
+ * @brief one record of the metrics stream, sent as one datagram
+ * @param magic METRICS_MAGIC, to drop foreign datagrams
+ * @param pid process id of the simulation, to kill a bad sweep job
+ * @param epoch second of the simulation (j_copy)
+ * @param sim_time simulation time at the end of the second [s]
+ * @param cbr last CBR measured by RSU [%]
+ * @param itt ITT selected from cbr [s]
+ * @param bsm_rx number of BSM received by RSU
+ * @param wsa_tx number of WSA sent by RSU
+ * @param pvd_rx number of PVD received by RSU
+ * @param events number of simulator events executed in the second
+ * @param wall_time wall clock time taken by the second [s]
+ */
+typedef struct {
+  uint32_t magic;
+  uint32_t pid;
+  uint32_t epoch;
+  uint32_t bsm_rx;
+  uint32_t wsa_tx;
+  uint32_t pvd_rx;
+  uint64_t events;
+  double sim_time;
+  double cbr;
+  double itt;
+  double wall_time;
+}METRICS;
+
+/**
+ * @brief sending side of the metrics stream
+ * @param fd datagram socket, -1 when the stream is disabled
+ * @param addr address of the socket V2X_monitor.cc is bound to
+ */
+typedef struct {
+  int fd = -1;
+  struct sockaddr_un addr;
+}METRICS_STREAM;
+
+/**
+ * @brief the function that opens the metrics stream
+ * @details callers leave the stream closed (fd -1) to disable streaming instead of calling this
+ * @param stream stream to open
+ * @param path path of the Unix domain socket, relative to the current directory when it
+ * @param path does not start with '/'; an empty path is an error (EINVAL)
+ * @return false when the path is empty or too long or the socket could not be created,
+ * @return errno tells why
+ */
+inline bool OpenMetricsStream (METRICS_STREAM* stream, const char* path)
+{
+  stream->fd = -1;
+  if (path == NULL || path[0] == '\0')
+    {
+      errno = EINVAL;
+      return false;
+    }
+  // a relative path is made absolute, so branches that chdir still reach the same reader
+  char abs_path[sizeof (stream->addr.sun_path)];
+  if (path[0] == '/')
+    abs_path[0] = '\0';
+  else if (getcwd (abs_path, sizeof (abs_path)) == NULL || strlen (abs_path) + 1 >= sizeof (abs_path))
+    {
+      errno = ENAMETOOLONG;
+      return false;
+    }
+  else
+    strcat (abs_path, "/");
+  if (strlen (abs_path) + strlen (path) >= sizeof (stream->addr.sun_path))
+    {
+      errno = ENAMETOOLONG;
+      return false;
+    }
+  strcat (abs_path, path);
+  int fd = socket (AF_UNIX, SOCK_DGRAM, 0);
+  if (fd < 0)
+    return false;
+  fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) | O_NONBLOCK);
+  memset (&stream->addr, 0, sizeof (stream->addr));
+  stream->addr.sun_family = AF_UNIX;
+  strcpy (stream->addr.sun_path, abs_path);
+  stream->fd = fd;
+  return true;
+}
+
+/**
+ * @brief the function that publishes one record without blocking
+ * @details the record is dropped when no reader is bound or its queue is full
+ */
+inline void PublishMetrics (const METRICS_STREAM* stream, METRICS* metrics)
+{
+  if (stream->fd < 0)
+    return;
+  metrics->magic = METRICS_MAGIC;
+  metrics->pid = getpid ();
+  sendto (stream->fd, metrics, sizeof (*metrics), MSG_DONTWAIT,
+          (const struct sockaddr*) &stream->addr, sizeof (stream->addr));
+}
+
+#endif /* V2X_METRICS_H */
@@ -0,0 +1,109 @@
+/**
+ * @file V2X_monitor.cc
+ * @brief reader of the live metrics stream of V2X_scen1.cc
+ * @details binds the Unix domain socket given with --metricsSocket and prints one line
+ * @details per second of simulation of every simulation publishing to it, with a bar of
+ * @details the CBR. Several simulations (e.g. a sweep) can publish to the same socket,
+ * @details the pid column tells them apart.
+ * @details
+ * @details Build without ns-3:  g++ -O2 -o V2X_monitor V2X_monitor.cc
+ * @details Usage:               ./V2X_monitor /tmp/v2x.sock [--csv]
+ * @details                      ./waf --run "V2X_scen1 --metricsSocket=/tmp/v2x.sock"
+ */
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "V2X_metrics.h"
+
+#define BAR_WIDTH 40  // width of the CBR bar
+#define BAR_FULL 200  // CBR [%] of a full bar
+
+static volatile sig_atomic_t stop = 0;
+
+static void Stop (int)
+{
+  stop = 1;
+}
+
+int main (int argc, char *argv[])
+{
+  if (argc < 2)
+    {
+      fprintf (stderr, "usage: %s SOCKET_PATH [--csv]\n", argv[0]);
+      return 1;
+    }
+  const char* path = argv[1];
+  bool csv = argc > 2 && std::string (argv[2]) == "--csv";
+
+  struct sockaddr_un addr;
+  if (strlen (path) >= sizeof (addr.sun_path))
+    {
+      fprintf (stderr, "socket path too long: %s\n", path);
+      return 1;
+    }
+  int fd = socket (AF_UNIX, SOCK_DGRAM, 0);
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  strcpy (addr.sun_path, path);
+  unlink (path);
+  if (fd < 0 || bind (fd, (struct sockaddr*) &addr, sizeof (addr)) < 0)
+    {
+      perror ("bind");
+      return 1;
+    }
+
+  // no SA_RESTART, so Ctrl-C interrupts recv and the socket file is removed
+  struct sigaction sa;
+  memset (&sa, 0, sizeof (sa));
+  sa.sa_handler = Stop;
+  sigaction (SIGINT, &sa, NULL);
+  sigaction (SIGTERM, &sa, NULL);
+
+  if (csv)
+    printf ("pid,epoch,sim_time,cbr,itt,bsm_rx,wsa_tx,pvd_rx,events,events_per_s,speed\n");
+  else
+    printf ("%7s %5s %8s %8s %6s %7s %5s %5s %10s %10s %7s\n", "pid", "epoch", "time[s]",
+            "cbr[%]", "itt[s]", "bsm_rx", "wsa", "pvd", "events", "events/s", "speed");
+  fflush (stdout);
+
+  while (!stop)
+    {
+      METRICS m;
+      ssize_t len = recv (fd, &m, sizeof (m), 0);
+      if (len < 0 && errno == EINTR)
+        continue;
+      if (len < 0)
+        {
+          perror ("recv");
+          break;
+        }
+      if (len != sizeof (m) || m.magic != METRICS_MAGIC)
+        continue;
+
+      double events_per_s = m.wall_time > 0 ? m.events / m.wall_time : 0;
+      double speed = m.wall_time > 0 ? 1.0 / m.wall_time : 0; // simulated seconds per wall second
+      if (csv)
+        {
+          printf ("%u,%u,%g,%g,%g,%u,%u,%u,%llu,%g,%g\n", m.pid, m.epoch, m.sim_time, m.cbr,
+                  m.itt, m.bsm_rx, m.wsa_tx, m.pvd_rx, (unsigned long long) m.events,
+                  events_per_s, speed);
+        }
+      else
+        {
+          int bar = (int) (m.cbr / BAR_FULL * BAR_WIDTH);
+          bar = bar < 0 ? 0 : bar > BAR_WIDTH ? BAR_WIDTH : bar;
+          printf ("%7u %5u %8.3f %8.2f %6.3f %7u %5u %5u %10llu %10.0f %7.3f |%.*s%*s|\n",
+                  m.pid, m.epoch, m.sim_time, m.cbr, m.itt, m.bsm_rx, m.wsa_tx, m.pvd_rx,
+                  (unsigned long long) m.events, events_per_s, speed,
+                  bar, "########################################", BAR_WIDTH - bar, "");
+        }
+      fflush (stdout);
+    }
+
+  close (fd);
+  unlink (path);
+  return 0;
+}
@@ -17,6 +17,7 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <algorithm>
 
 #include "ns3/ocb-wifi-mac.h"
 #include "ns3/wifi-80211p-helper.h"
@@ -29,6 +30,19 @@
 #include "ns3/applications-module.h"
 #include "ns3/internet-module.h"
 #include <random>
+#include <chrono>
+#include <memory>
+#include <cerrno>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <csignal>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "V2X_common.h"
+#include "V2X_metrics.h"
+#include "V2X_sketch.h"
 using namespace ns3;
 using std::string;
 using std::to_string;
@@ -54,12 +68,6 @@ typedef struct {
   float time_wsa = 0;
 }WSA;
 
-#define OBU_NODE 500
-#define RSU_NODE 1
-#define ROW_LINE 10
-#define TOTAL_TIME 100
-#define BSM_PACKET_SIZE 200
-#define BYTE_SIZE 8
 NS_LOG_COMPONENT_DEFINE ("WifiSimpleOcb");
 
 unsigned char recv_wsa_packet[100]; // buffer to save the WSA packet message
@@ -67,15 +75,30 @@ unsigned char recv_pvd_packet[100]; // buffer to save the PVD packet message
 float time_diff; // the time difference between the time the first node received the bsm and the time the last node gave the bsm
 int j_copy =0; // the number that equals the time the simulater runs and is updated every second.
 float ITT; // transmission time to send BSM
-float init_itt = 0.080; // initial transmission time
-Ptr<Packet> wsa_packet; // WSA Packet
-Ptr<Packet> pvd_packet; // PVD Packet
+float init_itt = INIT_ITT; // initial transmission time
+Ptr<Packet> wsa_packet; // WSA template packet, rebuilt only when the ITT data rate changes
+Ptr<Packet> pvd_packet; // PVD template packet, built once for the whole run
 std::string recv_itt_data; // string to save the ITT data
 std::string send_itt_data; // string to save the ITT data
 
 
 RSU rsu;
 WSA wsa;
+METRICS metrics; // metrics of the current second, published to the metrics stream at its end
+const ITT_TABLE* itt_table = &itt_tables[0]; // ITT policy table used by RSU
+SENDER_SKETCH sender_sketch; // per-sender BSM counts and last seen times at RSU, fixed memory
+
+/**
+ * @brief the function that rebuilds the WSA template packet from send_itt_data
+ * @details the WSA payload only changes when RSU selects a new ITT data rate, so the template
+ * @details is rebuilt only then and every WSA sent is a copy-on-write copy of it
+ */
+void UpdateWsaTemplate ()
+{
+  uint8_t packet_buffer[7] = {0};
+  std::copy_n (send_itt_data.begin (), std::min<size_t> (send_itt_data.size (), 7), packet_buffer);
+  wsa_packet = Create<Packet> (packet_buffer,7);
+}
 
 /**
  * @brief the function that RSU receives the PVD message from each OBU
@@ -85,6 +108,7 @@ void ReceivePacket_PVD (Ptr<Socket> socket)
 {
   while (socket->Recv (recv_pvd_packet,12,0))
     {
+      metrics.pvd_rx++;
       string st = "";
       for(int i = 0 ; i<12 ; i++)
         st += recv_pvd_packet[i];
@@ -115,8 +139,13 @@ void ReceivePacket_WSA (Ptr<Socket> socket)
  */
 void ReceivePacket_BSM (Ptr<Socket> socket)
 {
-  while (socket->Recv ())
+  Address from;
+  while (socket->RecvFrom (from))
     {
+      metrics.bsm_rx++;
+      if (sender_sketch.depth > 0 && InetSocketAddress::IsMatchingType (from))
+        UpdateSenderSketch (&sender_sketch, InetSocketAddress::ConvertFrom (from).GetIpv4 ().Get (),
+                            Simulator::Now ().GetSeconds ());
       if(rsu.arrival_num==0)
       {
           rsu.prev_time = Simulator::Now ().GetSeconds ();
@@ -138,12 +167,13 @@ void ReceivePacket_BSM (Ptr<Socket> socket)
             /**
              * @brief result of "(BSM_PACKET_SIZE*BYTE_SIZE)/(prev_itt*1000)" is output form of seconds
              */
-            cbr = (time_diff)*(prev_itt*1000)/(BSM_PACKET_SIZE*BYTE_ SIZE)*100;
+            cbr = (time_diff)*(prev_itt*1000)/(BSM_PACKET_SIZE*BYTE_SIZE)*100;
           
           std::cout << Simulator::Now ().GetSeconds () << "s>> Channel Busy Ratio: "<< cbr  << "[%]"<< std::endl;
           
           float m_simulationTime = rsu.current_time;
           float m_cbr = cbr;
+          metrics.cbr = cbr;
           std::ofstream out;
           out.open("V2X_variables2.csv", std::ios::app);
           out << m_simulationTime << ","
@@ -151,68 +181,18 @@ void ReceivePacket_BSM (Ptr<Socket> socket)
           out.close();
 
           /**
-           * @brief ITT is determined according to CBR
-           * @details Depending on the Qualcomm's report, C-V2X Congestion Control Study
-           * @details We decided the section of CBR and values of ITT as follows
+           * @brief ITT is determined according to CBR using the ITT policy table in V2X_common.h
            */
-          if(cbr!= 0 && cbr >=100 && cbr<110) // 0.107
-            {
-              send_itt_data = "15Kb/s";
-              ITT = 0.107;
-            }
-          else if(cbr!=0 && cbr>=110 && cbr<120) // 0.114
-            {
-              send_itt_data = "14Kb/s";
-              ITT = 0.114;
-            }
-          else if(cbr!=0 && cbr>=120 && cbr<130) // 0.123
-            {
-              send_itt_data = "13Kb/s";
-              ITT = 0.123;
-            }
-          else if(cbr!=0 && cbr>=130 && cbr<140) // 0.133
-            {
-              send_itt_data = "12Kb/s";
-              ITT = 0.133;
-            }
-          else if(cbr!=0 && cbr>=140 && cbr<150) // 0.145
-            {
-              send_itt_data = "11Kb/s";
-              ITT = 0.145;
-            }
-          else if(cbr!=0 && cbr>=150) // 0.16
-            {
-              send_itt_data = "10Kb/s";
-              ITT = 0.160;
-            }
-          else if(cbr!=0 && cbr>=90 && cbr<100) // 0.1
-            {
-              send_itt_data = "16Kb/s";
-              ITT = 0.100;
-            }
-          else if(cbr!=0 && cbr>=80 && cbr<90) // 0.094
-            {
-              send_itt_data = "17Kb/s";
-              ITT = 0.094;
-            }
-          else if(cbr!=0 && cbr>=70 && cbr<80) // 0.089
-            {
-              send_itt_data = "18Kb/s";
-              ITT = 0.089;
-            }
-          else if(cbr!=0 && cbr>=60 && cbr<70) // 0.084
-            {
-              send_itt_data = "19Kb/s";
-              ITT = 0.084;
-            }
-          else if(cbr!=0 && cbr<60) // 0.08
+          const ITT_POLICY* policy = FindIttPolicy (cbr, itt_table);
+          if (policy != NULL)
             {
-              send_itt_data = "20Kb/s";
-              ITT = 0.080;
+              ITT = policy->itt;
+              if (send_itt_data != policy->itt_data)
+                {
+                  send_itt_data = policy->itt_data;
+                  UpdateWsaTemplate ();
+                }
             }
-
-          uint8_t* packet_buffer = (uint8_t*)(&send_itt_data);
-          wsa_packet = Create<Packet> (packet_buffer,200);
       }
       rsu.arrival_num++;
 
@@ -231,7 +211,7 @@ void ReceivePacket_BSM (Ptr<Socket> socket)
 /**
  * @brief the function that sends the PVD packets
  * @param socket input socket
- * @param packet packet including the PVD
+ * @param packet template packet including the PVD, a copy of it is sent each time
  * @param pktCount number of times to send
  * @param pktInterval time interval at which packets are sent
  */
@@ -240,7 +220,7 @@ static void GenerateTraffic_PVD (Ptr<Socket> socket, Ptr<Packet> packet,
 {
   if (pktCount > 0)
     {
-      socket->Send (packet);
+      socket->Send (packet->Copy ());
       Simulator::Schedule (pktInterval, &GenerateTraffic_PVD,
                            socket, packet,pktCount - 1, pktInterval);
     }
@@ -250,26 +230,23 @@ static void GenerateTraffic_PVD (Ptr<Socket> socket, Ptr<Packet> packet,
     }
 }
 /**
- * @brief the function that generates the WSA and sends the WSA packets
- * @details RSU generates the WSA and sends the WSA to all OBUs
+ * @brief the function that sends the WSA packets
+ * @details RSU sends a copy of the current WSA template (wsa_packet) to all OBUs
  * @param socket input socket
- * @param packet packet to include the WSA
  * @param pktCount number of times to send
  * @param pktInterval time interval at which packets are sent
  */
-static void GenerateTraffic_WSA (Ptr<Socket> socket, Ptr<Packet> packet,
+static void GenerateTraffic_WSA (Ptr<Socket> socket,
                              uint32_t pktCount, Time pktInterval )
 {
   if (pktCount > 0)
     {
-      uint8_t packet_buffer[7]; 
-      std::copy(send_itt_data.begin(), send_itt_data.end(), std::begin(packet_buffer));
-      packet = Create<Packet> (packet_buffer,7);
-      socket->Send(packet);
+      socket->Send(wsa_packet->Copy ());
+      metrics.wsa_tx++;
       std::cout << Simulator::Now ().GetSeconds () << "s>> ITT(" << ITT << ")를 담은 WSA 메시지가 전송되었습니다." << std::endl;
       printf("\n");
       Simulator::Schedule (pktInterval, &GenerateTraffic_WSA,
-                           socket, packet,pktCount - 1, pktInterval);
+                           socket, pktCount - 1, pktInterval);
     }
   else
     {
@@ -277,6 +254,140 @@ static void GenerateTraffic_WSA (Ptr<Socket> socket, Ptr<Packet> packet,
     }
 }
 
+/**
+ * @brief the function that reports the OBUs sending more BSM than the ITT allows
+ * @details the heavy hitters of sender_sketch with more than hitter_factor times the BSM
+ * @details of one second at the ITT are printed and stored in V2X_heavy_hitters.csv
+ * @param epoch second of the simulation
+ * @param itt ITT OBUs were told to use in this second
+ * @param hitter_factor factor of the expected number of BSM to report a sender
+ */
+static void ReportHeavyHitters (int epoch, float itt, double hitter_factor)
+{
+  if (sender_sketch.depth == 0 || itt <= 0)
+    return;
+  double expected = 1.0 / itt;
+  std::vector<SENDER_HITTER> hitters =
+    FindHeavyHitters (&sender_sketch, (uint32_t) std::ceil (hitter_factor * expected));
+  if (hitters.empty ())
+    return;
+
+  std::ofstream out;
+  out.open("V2X_heavy_hitters.csv", std::ios::app);
+  for (size_t i = 0; i < hitters.size (); i++)
+    {
+      Ipv4Address sender (hitters[i].key);
+      double last_seen = EstimateSenderLastSeen (&sender_sketch, hitters[i].key);
+      std::cout << epoch << "s>> " << sender << " sent " << hitters[i].count
+                << " BSM (expected " << expected << "), last seen " << last_seen << "[s]" << std::endl;
+      out << epoch << "," << sender << "," << hitters[i].count << ","
+          << expected << "," << last_seen << std::endl;
+    }
+  out.close();
+}
+
+/**
+ * @brief the function that creates a directory of the branch outputs
+ * @details an existing directory is reused, any other error aborts the simulation
+ */
+static void MakeBranchDir (const string& dir)
+{
+  NS_ABORT_MSG_IF (mkdir (dir.c_str (), 0755) != 0 && errno != EEXIST,
+                   "cannot create directory " << dir << ": " << strerror (errno));
+}
+
+/**
+ * @brief the function that copies a log of the warm-up into a branch directory
+ * @details so that the per-branch logs start at t=0 like a run without branches
+ * @param file log file in the current directory, nothing is copied when it does not exist
+ * @param branch_dir directory of the branch
+ */
+static void CopyWarmUpLog (const string& file, const string& branch_dir)
+{
+  std::ifstream in (file.c_str (), std::ios::binary);
+  if (!in)
+    return;
+  std::ofstream out ((branch_dir + "/" + file).c_str (), std::ios::binary);
+  out << in.rdbuf ();
+  out.close ();
+}
+
+/**
+ * @brief the function that branches the simulation into one child process per ITT policy table
+ * @details called at the boundary of two seconds, when the simulator of the previous second
+ * @details is destroyed and the whole state of the scenario is in the global variables.
+ * @details fork() gives every child a copy-on-write snapshot of that state, so all children
+ * @details continue from the same warm-up with the same random streams and differ only in
+ * @details the ITT policy table. Each child runs in its own directory "<dir>/<k>-<policy>"
+ * @details which starts with a copy of V2X_variables2.csv and V2X_heavy_hitters.csv of the warm-up.
+ * @details if a fork fails, the branches already started are killed and the simulation aborts.
+ * @param tables ITT policy tables of the children
+ * @param dir parent directory of the child directories
+ * @param failed output number of branches that did not exit with 0, set in the parent only
+ * @return true in a child, false in the parent after all children finished
+ */
+static bool ForkBranches (const std::vector<const ITT_TABLE*>& tables, const string& dir, int* failed)
+{
+  std::cout.flush ();
+  fflush (stdout);
+  // every directory is created before the first fork, so a failure leaves no orphan branch
+  MakeBranchDir (dir);
+  std::vector<string> branch_dirs;
+  for (size_t k = 0; k < tables.size (); k++)
+    {
+      branch_dirs.push_back (dir + "/" + to_string (k) + "-" + tables[k]->name);
+      MakeBranchDir (branch_dirs[k]);
+    }
+
+  std::vector<pid_t> children;
+  for (size_t k = 0; k < tables.size (); k++)
+    {
+      const string& branch_dir = branch_dirs[k];
+      pid_t pid = fork ();
+      if (pid == 0)
+        {
+          CopyWarmUpLog ("V2X_variables2.csv", branch_dir);
+          CopyWarmUpLog ("V2X_heavy_hitters.csv", branch_dir);
+          if (chdir (branch_dir.c_str ()) != 0)
+            {
+              perror ("chdir");
+              _exit (1);
+            }
+          itt_table = tables[k];
+          std::cout << "Branch " << k << " (pid " << getpid () << ") continues with ITT policy "
+                    << itt_table->name << " in " << branch_dir << std::endl;
+          return true;
+        }
+      if (pid < 0)
+        {
+          int fork_errno = errno;
+          for (size_t i = 0; i < children.size (); i++)
+            {
+              kill (children[i], SIGTERM);
+              waitpid (children[i], NULL, 0);
+            }
+          NS_FATAL_ERROR ("cannot fork branch " << k << ": " << strerror (fork_errno));
+        }
+      children.push_back (pid);
+    }
+
+  *failed = 0;
+  for (size_t k = 0; k < children.size (); k++)
+    {
+      int status;
+      waitpid (children[k], &status, 0);
+      if (WIFEXITED (status))
+        std::cout << "Branch " << k << " (pid " << children[k] << ") finished with status "
+                  << WEXITSTATUS (status) << std::endl;
+      else
+        std::cout << "Branch " << k << " (pid " << children[k] << ") was killed by signal "
+                  << (WIFSIGNALED (status) ? WTERMSIG (status) : -1) << std::endl;
+      if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+        (*failed)++;
+    }
+  return false;
+}
+
 int main (int argc, char *argv[])
 {
   std::string phyMode ("OfdmRate6MbpsBW10MHz");
@@ -285,6 +396,16 @@ int main (int argc, char *argv[])
   std::string animFile = "wave-80211p.xml" ;
   double interval = 1.0;
   bool verbose = false;
+  std::string tracing = "full"; // full: pcap + ascii + animation, pcap: pcap + animation, none: no trace files
+  std::string metricsSocket = ""; // Unix domain socket of V2X_monitor, empty to disable
+  std::string policy = "qualcomm"; // ITT policy table in V2X_common.h
+  int forkEpoch = -1; // second at which the simulation branches, -1 to disable
+  std::string forkPolicies = "qualcomm,early,fixed"; // ITT policy tables of the branches
+  std::string forkDir = "branches"; // directory of the branch outputs
+  uint32_t sketchDepth = 4; // rows of the per-sender sketch at RSU, 0 to disable
+  uint32_t sketchWidth = 1024; // cells in one row of the per-sender sketch
+  uint32_t sketchHitters = 16; // heavy hitter candidates kept by the per-sender sketch
+  double hitterFactor = 2.0; // report senders with more than hitterFactor times the expected BSM
 
   CommandLine cmd (__FILE__);
 
@@ -294,15 +415,71 @@ int main (int argc, char *argv[])
   cmd.AddValue ("interval", "interval (seconds) between packets", interval);
   cmd.AddValue ("verbose", "turn on all WifiNetDevice log components", verbose);
   cmd.AddValue ("animFile",  "File Name for Animation Output", animFile);
+  cmd.AddValue ("tracing", "tracing profile: full (pcap, ascii and animation), pcap (pcap and animation) or none", tracing);
+  cmd.AddValue ("metricsSocket", "Unix domain socket to stream metrics of every second to", metricsSocket);
+  cmd.AddValue ("policy", "ITT policy table (qualcomm, early or fixed)", policy);
+  cmd.AddValue ("forkEpoch", "second at which the simulation forks into one branch per forkPolicies", forkEpoch);
+  cmd.AddValue ("forkPolicies", "comma separated ITT policy tables of the branches", forkPolicies);
+  cmd.AddValue ("forkDir", "directory of the branch outputs", forkDir);
+  cmd.AddValue ("sketchDepth", "rows of the per-sender BSM sketch at RSU, 0 to disable", sketchDepth);
+  cmd.AddValue ("sketchWidth", "cells in one row of the per-sender BSM sketch", sketchWidth);
+  cmd.AddValue ("sketchHitters", "heavy hitter candidates kept by the per-sender BSM sketch", sketchHitters);
+  cmd.AddValue ("hitterFactor", "report OBUs sending more than this times the BSM the ITT allows", hitterFactor);
   cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (tracing != "full" && tracing != "pcap" && tracing != "none",
+                   "unknown tracing profile " << tracing);
+  itt_table = FindIttTable (policy.c_str ());
+  NS_ABORT_MSG_IF (itt_table == NULL, "unknown ITT policy table " << policy);
+  std::vector<const ITT_TABLE*> fork_tables;
+  std::stringstream policies (forkPolicies);
+  for (string name; std::getline (policies, name, ',');)
+    {
+      const ITT_TABLE* table = FindIttTable (name.c_str ());
+      NS_ABORT_MSG_IF (table == NULL, "unknown ITT policy table " << name);
+      fork_tables.push_back (table);
+    }
+  NS_ABORT_MSG_IF (forkEpoch >= TOTAL_TIME, "forkEpoch must be less than " << TOTAL_TIME);
+  NS_ABORT_MSG_IF (forkEpoch >= 0 && fork_tables.empty (), "forkPolicies must name at least one ITT policy table");
+  NS_ABORT_MSG_IF (sketchDepth > 0 && sketchWidth == 0, "sketchWidth must be positive");
+  if (sketchDepth > 0)
+    InitSenderSketch (&sender_sketch, sketchDepth, sketchWidth, sketchHitters);
   Time interPacketInterval = Seconds (interval);
 
+  METRICS_STREAM metrics_stream;
+  NS_ABORT_MSG_IF (!metricsSocket.empty () && !OpenMetricsStream (&metrics_stream, metricsSocket.c_str ()),
+                   "cannot open metrics stream " << metricsSocket << ": " << strerror (errno));
+
+  /**
+   * @brief Enable packet metadata only when the tracing profile needs it
+   * @details the ascii trace prints the headers of every packet, which needs metadata.
+   * @details Enable() has to be called before the first packet is created.
+   */
+  if (tracing == "full")
+    ns3::PacketMetadata::Enable ();
+
+  /**
+   * @brief Build the template packets once, the generators send copies of them
+   */
+  UpdateWsaTemplate ();
+  string PVD_message = "car_info";
+  uint8_t PVD_buffer[15];
+  std::copy(PVD_message.begin(), PVD_message.end(), std::begin(PVD_buffer));
+  pvd_packet = Create<Packet> (PVD_buffer,8); // packet to send the PVD from OBUs to RSU
+
   /**
    * @brief Simulate every sec from 0 sec to TOTAL_TIME
    */
   for(int j = 0 ; j<TOTAL_TIME; j++)
   {
     j_copy = j;
+    /**
+     * @brief branch into one process per ITT policy table, the parent only waits for them
+     */
+    int failed_branches = 0;
+    if (j == forkEpoch && !ForkBranches (fork_tables, forkDir, &failed_branches))
+      return failed_branches == 0 ? 0 : 1;
+    float epoch_itt = (j == 0) ? init_itt : ITT; // ITT OBUs use in this second
     NodeContainer c;
     c.Create (OBU_NODE + RSU_NODE);
     
@@ -337,7 +514,8 @@ int main (int argc, char *argv[])
     NetDeviceContainer csma_devices = csma.Install (c);
 
     NetDeviceContainer total_devices = NetDeviceContainer (wave_devices, csma_devices);
-    wifiPhy.EnablePcap ("wave-simple-80211p", false);
+    if (tracing != "none")
+      wifiPhy.EnablePcap ("wave-simple-80211p", false);
 
     /**
      * @brief assign positions to each nodes
@@ -394,8 +572,8 @@ int main (int argc, char *argv[])
     source->SetAllowBroadcast (true);
     source->Connect (remote);
     Simulator::ScheduleWithContext (source->GetNode ()->GetId (),                     // OBUs send the WSA using GenerateTraffic_WSA function
-                                Seconds (j+1), &GenerateTraffic_WSA,                  // inputs of GenerateTraffic_PVD are source, wsa_packet
-                                source, wsa_packet, numPackets, interPacketInterval); // numPackets, and interPacketInterval
+                                Seconds (j+1), &GenerateTraffic_WSA,                  // inputs of GenerateTraffic_WSA are source,
+                                source, numPackets, interPacketInterval);             // numPackets, and interPacketInterval
     /**
      * @brief this step is all OBUs send the BSM to RSU
      * @details OBUs send the BSM packet according to itt based on csma and
@@ -412,7 +590,7 @@ int main (int argc, char *argv[])
       if(j!=0)
         onoff.SetConstantRate (DataRate (itt),BSM_PACKET_SIZE); // transmission varies according to itt and BSM_PACKET_SIZE.
       else
-        onoff.SetConstantRate (DataRate ("20Kb/s"),BSM_PACKET_SIZE); // initial transmission time
+        onoff.SetConstantRate (DataRate (INIT_ITT_DATA),BSM_PACKET_SIZE); // initial transmission time
       ApplicationContainer app = onoff.Install (c.Get (i)); // OBUs send the BSM using csma
       Ptr<Socket> recvSink = Socket::CreateSocket (c.Get (0), tid); // RSU is recv_socket
       InetSocketAddress local = InetSocketAddress (Ipv4Address("255.255.255.255"), port);
@@ -422,11 +600,6 @@ int main (int argc, char *argv[])
       app.Stop (Seconds (1.0001+j));
     }
 
-    /**
-     * @brief Construct a new ns3::Packet Metadata::Enable object
-     * @details Enable() must be set when sending real data in the packet.
-     */
-    ns3::PacketMetadata::Enable ();
     /**
      * @brief this step is the OBUs send the PVD to RSU
      * @details OBUs send the PVD data every sec using GenerateTraffic_PVD function and 
@@ -434,10 +607,6 @@ int main (int argc, char *argv[])
      */
     for(int i=1; i<OBU_NODE+RSU_NODE; i++)
       {
-        string PVD_message = "car_info";
-        uint8_t PVD_buffer[15];
-        std::copy(PVD_message.begin(), PVD_message.end(), std::begin(PVD_buffer));
-        pvd_packet = Create<Packet> (PVD_buffer,8); // packet to send the PVD from OBUs to RSU
         InetSocketAddress remote = InetSocketAddress (Ipv4Address ("255.255.255.255"), i);
         Ptr<Socket> recvSink = Socket::CreateSocket (c.Get (0), tid);
         InetSocketAddress local = InetSocketAddress (Ipv4Address("255.255.255.255"), i);
@@ -453,32 +622,58 @@ int main (int argc, char *argv[])
     /**
      * @brief Create trace file for WSA, PVD, and BSM
      */
-    AsciiTraceHelper ascii;
-    csma.EnableAsciiAll (ascii.CreateFileStream ("V2X_congestion_control.tr"));
+    if (tracing == "full")
+      {
+        AsciiTraceHelper ascii;
+        csma.EnableAsciiAll (ascii.CreateFileStream ("V2X_congestion_control.tr"));
+      }
 
     /**
      * @brief Create animation file for WSA, PVD, and BSM
      */
     NS_LOG_INFO ("Run Simulation.");
-    AnimationInterface anim (animFile);
-    uint32_t rsu_icon = anim.AddResource("/home/smsung/Pictures/Base.png");
-    uint32_t bluecar_icon = anim.AddResource("/home/smsung/Pictures/bluecar.png");
-    Ptr<Node> rsu = c.Get(0);
-    anim.UpdateNodeImage(rsu->GetId(),rsu_icon);
-    anim.UpdateNodeSize(0,3,3);
-
-    for (int i=1; i<OBU_NODE+1; i++)
-    {
-      Ptr<Node> greencar = c.Get(i);
-      anim.UpdateNodeImage(greencar->GetId(),bluecar_icon);
-    }
-    anim.SetMaxPktsPerTraceFile(500000);
+    std::unique_ptr<AnimationInterface> anim;
+    if (tracing != "none")
+      {
+        anim.reset (new AnimationInterface (animFile));
+        uint32_t rsu_icon = anim->AddResource("/home/smsung/Pictures/Base.png");
+        uint32_t bluecar_icon = anim->AddResource("/home/smsung/Pictures/bluecar.png");
+        Ptr<Node> rsu = c.Get(0);
+        anim->UpdateNodeImage(rsu->GetId(),rsu_icon);
+        anim->UpdateNodeSize(0,3,3);
+
+        for (int i=1; i<OBU_NODE+1; i++)
+        {
+          Ptr<Node> greencar = c.Get(i);
+          anim->UpdateNodeImage(greencar->GetId(),bluecar_icon);
+        }
+        anim->SetMaxPktsPerTraceFile(500000);
+      }
     /**
      * @brief Construct a new Simulator:: Run object
      * @details simulates the application sending BSM, WSA, and PVD
      */
+    std::chrono::steady_clock::time_point wall_start = std::chrono::steady_clock::now ();
     Simulator::Run ();
-    std::cout << "Animation Trace file created:" << animFile.c_str ()<< std::endl;
+    if (anim)
+      std::cout << "Animation Trace file created:" << animFile.c_str ()<< std::endl;
+
+    /**
+     * @brief publish the metrics of this second to the metrics stream without blocking
+     */
+    metrics.epoch = j;
+    metrics.sim_time = Simulator::Now ().GetSeconds ();
+    metrics.itt = ITT;
+    metrics.events = Simulator::GetEventCount ();
+    metrics.wall_time = std::chrono::duration<double> (std::chrono::steady_clock::now () - wall_start).count ();
+    PublishMetrics (&metrics_stream, &metrics);
+    metrics.bsm_rx = metrics.wsa_tx = metrics.pvd_rx = 0;
+
+    /**
+     * @brief report the OBUs over-sending BSM in this second and start a new window
+     */
+    ReportHeavyHitters (j, epoch_itt, hitterFactor);
+    ResetSenderSketchWindow (&sender_sketch);
     Simulator::Destroy ();
 
   }
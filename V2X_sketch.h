@@ -0,0 +1,171 @@
+#ifndef V2X_SKETCH_H
+#define V2X_SKETCH_H
+
+/**
+ * @file V2X_sketch.h
+ * @brief fixed-memory per-sender BSM rate tracker for the RSU
+ * @details a count-min sketch with conservative update counts the BSMs of every sender
+ * @details in the current window, a second sketch of the same shape keeps the last time a
+ * @details sender was seen, and a small candidate table keeps the senders with the largest
+ * @details counts (heavy hitters). Memory and per-packet cost depend only on depth, width
+ * @details and the number of candidates, not on the number of vehicles. Estimates never
+ * @details undercount: a count or last seen time may be too large by the collisions in
+ * @details the best row, which is bounded by total / width with high probability.
+ * @details this header must not depend on ns-3
+ */
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * @brief one heavy hitter candidate
+ * @param key sender id (IPv4 address)
+ * @param count estimated number of BSMs in the current window
+ */
+typedef struct {
+  uint32_t key;
+  uint32_t count;
+}SENDER_HITTER;
+
+/**
+ * @brief count-min sketch of per-sender BSM counts and last seen times
+ * @param depth number of rows (hash functions)
+ * @param width number of cells in one row
+ * @param count BSM count of every cell in the current window, depth x width
+ * @param last_seen time of the last BSM of every cell, kept across windows
+ * @param hitters heavy hitter candidates, at most max_hitters
+ * @param total number of BSMs in the current window
+ */
+typedef struct {
+  uint32_t depth = 0;
+  uint32_t width = 0;
+  uint32_t max_hitters = 0;
+  std::vector<uint32_t> count;
+  std::vector<double> last_seen;
+  std::vector<SENDER_HITTER> hitters;
+  uint64_t total = 0;
+}SENDER_SKETCH;
+
+/**
+ * @brief the function that allocates the sketch once, its size never changes afterwards
+ */
+inline void InitSenderSketch (SENDER_SKETCH* sketch, uint32_t depth, uint32_t width,
+                              uint32_t max_hitters)
+{
+  sketch->depth = depth;
+  sketch->width = width;
+  sketch->max_hitters = max_hitters;
+  sketch->count.assign ((size_t) depth * width, 0);
+  sketch->last_seen.assign ((size_t) depth * width, -1);
+  sketch->hitters.clear ();
+  sketch->hitters.reserve (max_hitters);
+  sketch->total = 0;
+}
+
+/**
+ * @brief the function that maps a sender to its cell in one row
+ * @details splitmix64 finalizer of the key mixed with a per-row seed
+ */
+inline size_t SenderSketchCell (const SENDER_SKETCH* sketch, uint32_t row, uint32_t key)
+{
+  uint64_t x = key + (row + 1) * 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  x = x ^ (x >> 31);
+  return (size_t) row * sketch->width + x % sketch->width;
+}
+
+/**
+ * @brief the function that estimates the BSM count of a sender in the current window
+ */
+inline uint32_t EstimateSenderCount (const SENDER_SKETCH* sketch, uint32_t key)
+{
+  uint32_t estimate = UINT32_MAX;
+  for (uint32_t row = 0; row < sketch->depth; row++)
+    {
+      uint32_t c = sketch->count[SenderSketchCell (sketch, row, key)];
+      estimate = c < estimate ? c : estimate;
+    }
+  return estimate;
+}
+
+/**
+ * @brief the function that estimates the time a sender was last seen
+ * @return time of the last BSM, or a negative value when the sender was never seen
+ */
+inline double EstimateSenderLastSeen (const SENDER_SKETCH* sketch, uint32_t key)
+{
+  double estimate = -1;
+  for (uint32_t row = 0; row < sketch->depth; row++)
+    {
+      double t = sketch->last_seen[SenderSketchCell (sketch, row, key)];
+      estimate = (row == 0 || t < estimate) ? t : estimate;
+    }
+  return estimate;
+}
+
+/**
+ * @brief the function that counts one BSM of a sender
+ * @details conservative update: only the cells at the current minimum are incremented,
+ * @details then the sender replaces the smallest heavy hitter candidate if it is larger
+ * @param sketch sketch to update
+ * @param key sender id (IPv4 address)
+ * @param now arrival time of the BSM [s]
+ */
+inline void UpdateSenderSketch (SENDER_SKETCH* sketch, uint32_t key, double now)
+{
+  uint32_t estimate = EstimateSenderCount (sketch, key) + 1;
+  for (uint32_t row = 0; row < sketch->depth; row++)
+    {
+      size_t cell = SenderSketchCell (sketch, row, key);
+      if (sketch->count[cell] < estimate)
+        sketch->count[cell] = estimate;
+      if (sketch->last_seen[cell] < now)
+        sketch->last_seen[cell] = now;
+    }
+  sketch->total++;
+
+  size_t smallest = 0;
+  for (size_t i = 0; i < sketch->hitters.size (); i++)
+    {
+      if (sketch->hitters[i].key == key)
+        {
+          sketch->hitters[i].count = estimate;
+          return;
+        }
+      if (sketch->hitters[i].count < sketch->hitters[smallest].count)
+        smallest = i;
+    }
+  SENDER_HITTER hitter = {key, estimate};
+  if (sketch->hitters.size () < sketch->max_hitters)
+    sketch->hitters.push_back (hitter);
+  else if (sketch->max_hitters > 0 && sketch->hitters[smallest].count < estimate)
+    sketch->hitters[smallest] = hitter;
+}
+
+/**
+ * @brief the function that returns the candidates with at least min_count BSMs
+ */
+inline std::vector<SENDER_HITTER> FindHeavyHitters (const SENDER_SKETCH* sketch, uint32_t min_count)
+{
+  std::vector<SENDER_HITTER> result;
+  for (size_t i = 0; i < sketch->hitters.size (); i++)
+    {
+      if (sketch->hitters[i].count >= min_count)
+        result.push_back (sketch->hitters[i]);
+    }
+  return result;
+}
+
+/**
+ * @brief the function that starts a new window, last seen times are kept
+ */
+inline void ResetSenderSketchWindow (SENDER_SKETCH* sketch)
+{
+  sketch->count.assign (sketch->count.size (), 0);
+  sketch->hitters.clear ();
+  sketch->total = 0;
+}
+
+#endif /* V2X_SKETCH_H */
@@ -0,0 +1,435 @@
+/**
+ * @file V2X_surrogate.cc
+ * @brief analytical surrogate of V2X_scen1.cc that predicts CBR and the ITT trajectory
+ * @details V2X_scen1.cc measures CBR at the RSU as the time between the first and the
+ * @details (OBU_NODE-1)th BSM arrival of one second divided by the ITT. All OBUs start
+ * @details their BSM at the same time, so that time is the airtime of OBU_NODE-1 BSMs
+ * @details sent back to back, and the ITT of the next second follows from the ITT
+ * @details policy table. The surrogate evaluates this model for every second, so a
+ * @details whole run takes microseconds and a sweep point can be classified as idle,
+ * @details saturated or interesting before spending a full ns-3 run on it.
+ * @details
+ * @details Build without ns-3:  g++ -O2 -o V2X_surrogate V2X_surrogate.cc
+ * @details Single run:          ./V2X_surrogate --obuNodes=500 --trajectory
+ * @details Sweep:               ./V2X_surrogate --sweepMin=50 --sweepMax=2000 --sweepStep=50
+ * @details Calibration:         ./V2X_surrogate --obuNodes=500 --calibrate=V2X_variables2.csv
+ * @details Other ITT policy:    ./V2X_surrogate --policy=early (qualcomm, early or fixed)
+ * @details The scale printed by the calibration is then passed with --scale.
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "V2X_common.h"
+
+using std::string;
+
+/**
+ * @brief OFDM timing of 802.11p for one channel bandwidth
+ * @param symbol OFDM symbol duration [s]
+ * @param preamble PLCP preamble and SIGNAL field duration [s]
+ * @param slot slot time [s]
+ * @param sifs SIFS duration [s]
+ */
+typedef struct {
+  double symbol;
+  double preamble;
+  double slot;
+  double sifs;
+}OFDM_TIMING;
+
+/**
+ * @brief parameters of the surrogate model
+ * @param obu_node number of OBUs sending BSM
+ * @param packet_size size of BSM payload [byte]
+ * @param phy_mode wifi phy mode of V2X_scen1.cc
+ * @param epochs number of seconds to evaluate
+ * @param scale calibration factor applied to the channel time of one BSM
+ * @param table ITT policy table in V2X_common.h
+ */
+typedef struct {
+  int obu_node = OBU_NODE;
+  int packet_size = BSM_PACKET_SIZE;
+  string phy_mode = "OfdmRate6MbpsBW10MHz";
+  int epochs = TOTAL_TIME;
+  double scale = 1.0;
+  const ITT_TABLE* table = &itt_tables[0];
+}MODEL;
+
+/**
+ * @brief result of one evaluated second
+ * @param itt ITT used by OBUs in this second, derived from the BSM data rate
+ * @param cbr CBR measured by RSU at the end of this second [%]
+ * @param policy section of the ITT policy table selected from cbr
+ */
+typedef struct {
+  double itt;
+  double cbr;
+  const ITT_POLICY* policy;
+}EPOCH;
+
+#define MAC_OVERHEAD 64 // MAC header 24, LLC 8, IPv4 20, UDP 8, FCS 4 [byte]
+#define AIFSN 2         // DIFS of the non-QoS OCB MAC installed by NqosWaveMacHelper
+#define CW_MIN 15
+
+/**
+ * @brief the function that parses "OfdmRate<rate>MbpsBW<bw>MHz" phy modes
+ * @param phy_mode phy mode string, e.g. OfdmRate6MbpsBW10MHz or OfdmRate4_5MbpsBW10MHz
+ * @param rate output data rate [bit/s]
+ * @param timing output OFDM timing of the bandwidth
+ * @return false when the phy mode is not an 802.11p OFDM mode
+ */
+static bool ParsePhyMode (const string& phy_mode, double* rate, OFDM_TIMING* timing)
+{
+  size_t rate_pos = phy_mode.find ("OfdmRate");
+  size_t mbps_pos = phy_mode.find ("MbpsBW");
+  size_t mhz_pos = phy_mode.find ("MHz");
+  if (rate_pos != 0 || mbps_pos == string::npos || mhz_pos == string::npos)
+    return false;
+
+  string rate_str = phy_mode.substr (8, mbps_pos - 8);
+  for (size_t i = 0; i < rate_str.size (); i++)
+    {
+      if (rate_str[i] == '_')
+        rate_str[i] = '.';
+    }
+  *rate = atof (rate_str.c_str ()) * 1e6;
+  int bw = atoi (phy_mode.substr (mbps_pos + 6, mhz_pos - mbps_pos - 6).c_str ());
+
+  if (*rate <= 0)
+    return false;
+  switch (bw)
+    {
+    case 20:
+      *timing = {4e-6, 20e-6, 9e-6, 16e-6};
+      return true;
+    case 10:
+      *timing = {8e-6, 40e-6, 13e-6, 32e-6};
+      return true;
+    case 5:
+      *timing = {16e-6, 80e-6, 21e-6, 64e-6};
+      return true;
+    default:
+      return false;
+    }
+}
+
+/**
+ * @brief the function that calculates the channel time of one BSM
+ * @details airtime of the PPDU plus AIFS and the mean backoff of an idle channel
+ * @param model model parameters
+ * @return channel time of one BSM [s], or a negative value for an unknown phy mode
+ */
+static double BsmChannelTime (const MODEL& model)
+{
+  double rate;
+  OFDM_TIMING timing;
+  if (!ParsePhyMode (model.phy_mode, &rate, &timing))
+    return -1;
+
+  double bits_per_symbol = rate * timing.symbol;
+  double bits = 16 + (model.packet_size + MAC_OVERHEAD) * BYTE_SIZE + 6; // SERVICE + PSDU + tail
+  double airtime = timing.preamble + std::ceil (bits / bits_per_symbol) * timing.symbol;
+  double aifs = timing.sifs + AIFSN * timing.slot;
+  double backoff = CW_MIN / 2.0 * timing.slot;
+  return airtime + aifs + backoff;
+}
+
+/**
+ * @brief the function that converts the BSM data rate in the WSA to ITT
+ * @details OBUs send BSM with OnOffHelper::SetConstantRate, so the ITT is size/rate
+ * @param itt_data data rate string such as "15Kb/s"
+ * @param packet_size size of BSM payload [byte]
+ */
+static double IttFromData (const char* itt_data, int packet_size)
+{
+  return packet_size * BYTE_SIZE / (atof (itt_data) * 1000);
+}
+
+/**
+ * @brief the function that predicts the CBR and ITT of every second
+ * @details CBR = (obu_node-1) * channel time / ITT * 100, as RSU measures it in V2X_scen1.cc
+ * @param model model parameters
+ * @param channel_time channel time of one BSM [s]
+ * @return CBR, ITT and policy section of every second
+ */
+static std::vector<EPOCH> Simulate (const MODEL& model, double channel_time)
+{
+  std::vector<EPOCH> trajectory;
+  double itt = IttFromData (INIT_ITT_DATA, model.packet_size);
+  for (int j = 0; j < model.epochs; j++)
+    {
+      EPOCH epoch;
+      epoch.itt = itt;
+      epoch.cbr = (model.obu_node - 1) * channel_time * model.scale / itt * 100;
+      epoch.policy = FindIttPolicy (epoch.cbr, model.table);
+      if (epoch.policy != NULL)
+        itt = IttFromData (epoch.policy->itt_data, model.packet_size);
+      trajectory.push_back (epoch);
+    }
+  return trajectory;
+}
+
+/**
+ * @brief the function that finds the steady state of a trajectory
+ * @details the policy section is the only state carried between seconds, so the
+ * @details trajectory ends in a cycle whose length is at most the number of sections
+ * @param trajectory result of Simulate
+ * @param table ITT policy table the trajectory was simulated with
+ * @param cbr output mean CBR over the cycle [%]
+ * @param itt output mean ITT over the cycle [s]
+ * @return cycle length, 1 for a fixed point and 0 when no cycle is found
+ */
+static int SteadyState (const std::vector<EPOCH>& trajectory, const ITT_TABLE* table,
+                        double* cbr, double* itt)
+{
+  int n = trajectory.size ();
+  *cbr = n > 0 ? trajectory[n - 1].cbr : 0;
+  *itt = n > 0 ? trajectory[n - 1].itt : 0;
+  for (int period = 1; period <= (int) table->num && 2 * period <= n; period++)
+    {
+      if (trajectory[n - 1].policy != trajectory[n - 1 - period].policy)
+        continue;
+      double sum_cbr = 0, sum_itt = 0;
+      for (int k = n - period; k < n; k++)
+        {
+          sum_cbr += trajectory[k].cbr;
+          sum_itt += trajectory[k].itt;
+        }
+      *cbr = sum_cbr / period;
+      *itt = sum_itt / period;
+      return period;
+    }
+  return 0;
+}
+
+/**
+ * @brief the function that fits the scale of the model to a V2X_variables2.csv of ns-3
+ * @details each line of the csv file is "time,cbr,wsa time,next itt": cbr was measured
+ * @details with the ITT of the previous line (INIT_ITT in the first second). The first
+ * @details line is only "wsa time,itt", as is a line of a second without CBR, and the last
+ * @details line is only "time,cbr,". The scale is the least squares fit of
+ * @details measured cbr = scale * predicted cbr.
+ * @param model model parameters of the ns-3 run
+ * @param channel_time channel time of one BSM [s]
+ * @param path path of the csv file
+ * @param scale output fitted scale
+ * @return number of CBR samples used, 0 when nothing could be fitted
+ */
+static int Calibrate (const MODEL& model, double channel_time, const string& path, double* scale)
+{
+  std::ifstream in (path.c_str ());
+  if (!in)
+    return 0;
+
+  double itt = IttFromData (INIT_ITT_DATA, model.packet_size);
+  double sum_xy = 0, sum_xx = 0;
+  int samples = 0;
+  string line;
+  while (std::getline (in, line))
+    {
+      std::vector<string> fields;
+      std::stringstream ss (line);
+      string field;
+      while (std::getline (ss, field, ','))
+        fields.push_back (field);
+      bool has_sample = fields.size () == 4 || (fields.size () == 2 && line[line.size () - 1] == ',');
+      if (has_sample)
+        {
+          double measured = atof (fields[1].c_str ());
+          double predicted = (model.obu_node - 1) * channel_time / itt * 100;
+          sum_xy += measured * predicted;
+          sum_xx += predicted * predicted;
+          samples++;
+        }
+
+      double next_itt = 0;
+      if (fields.size () == 4)
+        next_itt = atof (fields[3].c_str ());
+      else if (fields.size () == 2 && !has_sample)
+        next_itt = atof (fields[1].c_str ());
+      if (next_itt > 0)
+        itt = next_itt;
+    }
+  if (samples == 0 || sum_xx == 0)
+    return 0;
+  *scale = sum_xy / sum_xx;
+  return samples;
+}
+
+/**
+ * @brief the function that classifies a steady state for a sweep
+ * @details in the first section of the policy table the ITT cannot shrink any more and in
+ * @details the last section it cannot grow any more. A point is idle or saturated only when
+ * @details every second of its cycle stays in that section; a cycle that crosses sections
+ * @details (an oscillating controller) or no cycle at all is worth a full ns-3 run.
+ * @details A table with one section never changes the ITT, so it cannot pre-screen anything.
+ * @param trajectory result of Simulate
+ * @param table ITT policy table the trajectory was simulated with
+ * @param period cycle length returned by SteadyState
+ */
+static const char* Classify (const std::vector<EPOCH>& trajectory, const ITT_TABLE* table, int period)
+{
+  int n = trajectory.size ();
+  if (period <= 0 || period > n || table->num < 2)
+    return "interesting";
+  bool idle = true, saturated = true;
+  for (int k = n - period; k < n; k++)
+    {
+      idle = idle && trajectory[k].policy == &table->sections[0];
+      saturated = saturated && trajectory[k].policy == &table->sections[table->num - 1];
+    }
+  if (idle)
+    return "idle";
+  if (saturated)
+    return "saturated";
+  return "interesting";
+}
+
+int main (int argc, char *argv[])
+{
+  MODEL model;
+  bool trajectory = false;
+  string calibrate = "";
+  int sweep_min = 2, sweep_max = 0, sweep_step = 1;
+  bool sweep_bounds = false; // --sweepMin or --sweepStep given
+
+  for (int i = 1; i < argc; i++)
+    {
+      string arg = argv[i];
+      size_t eq = arg.find ('=');
+      string name = arg.substr (0, eq);
+      string value = eq == string::npos ? "" : arg.substr (eq + 1);
+      if (name == "--obuNodes")
+        model.obu_node = atoi (value.c_str ());
+      else if (name == "--packetSize")
+        model.packet_size = atoi (value.c_str ());
+      else if (name == "--phyMode")
+        model.phy_mode = value;
+      else if (name == "--epochs")
+        model.epochs = atoi (value.c_str ());
+      else if (name == "--scale")
+        model.scale = atof (value.c_str ());
+      else if (name == "--policy")
+        {
+          model.table = FindIttTable (value.c_str ());
+          if (model.table == NULL)
+            {
+              std::cerr << "unknown ITT policy table " << value << std::endl;
+              return 1;
+            }
+        }
+      else if (name == "--trajectory")
+        trajectory = true;
+      else if (name == "--calibrate")
+        calibrate = value;
+      else if (name == "--sweepMin")
+        {
+          sweep_min = atoi (value.c_str ());
+          sweep_bounds = true;
+        }
+      else if (name == "--sweepMax")
+        sweep_max = atoi (value.c_str ());
+      else if (name == "--sweepStep")
+        {
+          sweep_step = atoi (value.c_str ());
+          sweep_bounds = true;
+        }
+      else
+        {
+          std::cerr << "usage: " << argv[0] << " [--obuNodes=N] [--packetSize=BYTES]"
+                    << " [--phyMode=MODE] [--epochs=N] [--scale=S] [--policy=NAME] [--trajectory]"
+                    << " [--calibrate=CSV] [--sweepMin=N --sweepMax=N [--sweepStep=N]]"
+                    << std::endl;
+          return 1;
+        }
+    }
+
+  if (model.obu_node < 2 || (sweep_max > 0 && sweep_min < 2))
+    {
+      std::cerr << "the number of OBUs must be at least 2" << std::endl;
+      return 1;
+    }
+  if (model.epochs < 1)
+    {
+      std::cerr << "epochs must be at least 1" << std::endl;
+      return 1;
+    }
+  if (model.packet_size <= 0)
+    {
+      std::cerr << "packetSize must be positive" << std::endl;
+      return 1;
+    }
+  if (model.scale <= 0)
+    {
+      std::cerr << "scale must be positive" << std::endl;
+      return 1;
+    }
+  if (sweep_bounds && sweep_max <= 0)
+    {
+      std::cerr << "sweepMin and sweepStep need sweepMax" << std::endl;
+      return 1;
+    }
+  if (sweep_max > 0 && (sweep_step <= 0 || sweep_max < sweep_min))
+    {
+      std::cerr << "sweepStep must be positive and sweepMax at least sweepMin" << std::endl;
+      return 1;
+    }
+
+  double channel_time = BsmChannelTime (model);
+  if (channel_time < 0)
+    {
+      std::cerr << "unsupported phyMode: " << model.phy_mode << std::endl;
+      return 1;
+    }
+
+  if (!calibrate.empty ())
+    {
+      double scale;
+      int samples = Calibrate (model, channel_time, calibrate, &scale);
+      if (samples == 0)
+        {
+          std::cerr << "no CBR samples in " << calibrate << std::endl;
+          return 1;
+        }
+      std::cout << "samples," << samples << std::endl;
+      std::cout << "scale," << scale << std::endl;
+      return 0;
+    }
+
+  if (sweep_max > 0)
+    {
+      std::cout << "obu_node,cbr,itt,period,class" << std::endl;
+      for (int n = sweep_min; n <= sweep_max; n += sweep_step)
+        {
+          model.obu_node = n;
+          double cbr, itt;
+          std::vector<EPOCH> result = Simulate (model, channel_time);
+          int period = SteadyState (result, model.table, &cbr, &itt);
+          std::cout << n << "," << cbr << "," << itt << "," << period << ","
+                    << Classify (result, model.table, period) << std::endl;
+        }
+      return 0;
+    }
+
+  std::vector<EPOCH> result = Simulate (model, channel_time);
+  if (trajectory)
+    {
+      std::cout << "time,itt,cbr,next_itt_data" << std::endl;
+      for (size_t j = 0; j < result.size (); j++)
+        std::cout << j << "," << result[j].itt << "," << result[j].cbr << ","
+                  << (result[j].policy != NULL ? result[j].policy->itt_data : "") << std::endl;
+    }
+  double cbr, itt;
+  int period = SteadyState (result, model.table, &cbr, &itt);
+  std::cout << "channel_time," << channel_time << std::endl;
+  std::cout << "cbr," << cbr << std::endl;
+  std::cout << "itt," << itt << std::endl;
+  std::cout << "period," << period << std::endl;
+  std::cout << "class," << Classify (result, model.table, period) << std::endl;
+  return 0;
+}